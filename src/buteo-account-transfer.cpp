@@ -0,0 +1,131 @@
+/*
+ * Copyright 2015 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Renato Araujo Oliveira Filho <renato.filho@canonical.com>
+ */
+
+#include "buteo-account-transfer.h"
+
+using namespace unity::indicator::transfer;
+
+namespace {
+
+// the aggregate shows the state that needs more attention from the user
+int stateSeverity(Transfer::State state)
+{
+    switch(state) {
+    case Transfer::FINISHED:
+        return 0;
+    case Transfer::CANCELED:
+        return 1;
+    case Transfer::RUNNING:
+        return 3;
+    case Transfer::ERROR:
+        return 4;
+    default:
+        return 2;
+    }
+}
+
+}
+
+ButeoAccountTransfer::ButeoAccountTransfer(const QString &accountTransferId,
+                                           const QVariantMap &fields)
+    : ButeoTransfer(accountTransferId, fields)
+{
+}
+
+void ButeoAccountTransfer::addProfile(const std::shared_ptr<ButeoTransfer> &transfer)
+{
+    removeProfile(QString::fromStdString(transfer->id));
+    m_members << transfer;
+}
+
+void ButeoAccountTransfer::removeProfile(const QString &profileId)
+{
+    for (int i = 0; i < m_members.size(); i++) {
+        if (m_members.at(i)->id == profileId.toStdString()) {
+            m_members.removeAt(i);
+            return;
+        }
+    }
+}
+
+QStringList ButeoAccountTransfer::profiles() const
+{
+    QStringList result;
+    for (const std::shared_ptr<ButeoTransfer> &transfer : m_members) {
+        result << QString::fromStdString(transfer->id);
+    }
+    return result;
+}
+
+bool ButeoAccountTransfer::isEmpty() const
+{
+    return m_members.isEmpty();
+}
+
+bool ButeoAccountTransfer::refresh()
+{
+    Transfer::State oldState = state;
+    float oldProgress = progress;
+    std::string oldCustomState = custom_state;
+    std::string oldErrorString = error_string;
+
+    // profiles never synced weigh as much as the average known sync
+    gint64 knownDuration = 0;
+    int knownCount = 0;
+    for (const std::shared_ptr<ButeoTransfer> &transfer : m_members) {
+        if (transfer->lastSyncDuration() > 0) {
+            knownDuration += transfer->lastSyncDuration();
+            knownCount++;
+        }
+    }
+    qreal defaultWeight = (knownCount > 0) ? (qreal(knownDuration) / knownCount) : 1.0;
+
+    std::shared_ptr<ButeoTransfer> worst;
+    qreal totalWeight = 0.0;
+    qreal doneWeight = 0.0;
+    for (const std::shared_ptr<ButeoTransfer> &transfer : m_members) {
+        if (!worst || (stateSeverity(transfer->state) > stateSeverity(worst->state))) {
+            worst = transfer;
+        }
+
+        qreal weight = defaultWeight;
+        if (transfer->lastSyncDuration() > 0) {
+            weight = transfer->lastSyncDuration();
+        }
+
+        totalWeight += weight;
+        if (transfer->state == Transfer::FINISHED) {
+            doneWeight += weight;
+        } else {
+            doneWeight += weight * transfer->progress;
+        }
+    }
+
+    if (worst) {
+        state = worst->state;
+        custom_state = worst->custom_state;
+        error_string = worst->error_string;
+    }
+    progress = (totalWeight > 0.0) ? (doneWeight / totalWeight) : 0.0;
+
+    return (oldState != state) ||
+           (oldProgress != progress) ||
+           (oldCustomState != custom_state) ||
+           (oldErrorString != error_string);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2015 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Renato Araujo Oliveira Filho <renato.filho@canonical.com>
+ */
+
+#ifndef __BUTEO_ACCOUNT_TRANSFER_H__
+#define __BUTEO_ACCOUNT_TRANSFER_H__
+
+#include "buteo-transfer.h"
+
+#include <memory>
+
+#include <QtCore/QList>
+#include <QtCore/QStringList>
+
+namespace unity {
+namespace indicator {
+namespace transfer {
+
+// Groups all profiles of an account in a single transfer
+class ButeoAccountTransfer : public ButeoTransfer
+{
+public:
+    ButeoAccountTransfer(const QString &accountTransferId,
+                         const QVariantMap &fields);
+
+    void addProfile(const std::shared_ptr<ButeoTransfer> &transfer);
+    void removeProfile(const QString &profileId);
+    QStringList profiles() const;
+    bool isEmpty() const;
+
+    // update the aggregate state from the profiles, the progress of each
+    // profile weighs as much as its last sync took;
+    // returns true if any visible field has changed
+    bool refresh();
+
+private:
+    QList<std::shared_ptr<ButeoTransfer> > m_members;
+};
+
+} // namespace transfer
+} // namespace indicator
+} // namespace unity
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2015 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Renato Araujo Oliveira Filho <renato.filho@canonical.com>
+ */
+
+
+#include "buteo-profile.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QString>
+
+#include <glib.h>
+
+#ifndef USE_GMARKUP
+#include <QtXml/QDomDocument>
+#endif
+
+namespace {
+
+// collect the attributes of every <key> element, like the QDom parser does
+void onProfileElement(GMarkupParseContext *context,
+                      const gchar *elementName,
+                      const gchar **attributeNames,
+                      const gchar **attributeValues,
+                      gpointer userData,
+                      GError **error)
+{
+    Q_UNUSED(context);
+    Q_UNUSED(error);
+
+    if (g_strcmp0(elementName, "key") != 0) {
+        return;
+    }
+
+    const gchar *name = "";
+    const gchar *value = "";
+    for (int i = 0; attributeNames[i] != nullptr; i++) {
+        if (g_strcmp0(attributeNames[i], "name") == 0) {
+            name = attributeValues[i];
+        } else if (g_strcmp0(attributeNames[i], "value") == 0) {
+            value = attributeValues[i];
+        }
+    }
+
+    QVariantMap *result = static_cast<QVariantMap*>(userData);
+    result->insert(QString::fromUtf8(name), QString::fromUtf8(value));
+}
+
+}
+
+namespace unity {
+namespace indicator {
+namespace transfer {
+
+QVariantMap parseProfileXml(const char *profileXml)
+{
+#ifdef USE_GMARKUP
+    return parseProfileXmlGMarkup(profileXml);
+#else
+    return parseProfileXmlDom(profileXml);
+#endif
+}
+
+QVariantMap parseProfileXmlGMarkup(const char *profileXml)
+{
+    QVariantMap result;
+    GError *gError = nullptr;
+    GMarkupParser parser = { onProfileElement, nullptr, nullptr, nullptr, nullptr };
+    GMarkupParseContext *context = g_markup_parse_context_new(&parser,
+                                                              (GMarkupParseFlags) 0,
+                                                              &result,
+                                                              nullptr);
+    if (!g_markup_parse_context_parse(context, profileXml, -1, &gError) ||
+        !g_markup_parse_context_end_parse(context, &gError)) {
+        qWarning() << "Fail to parse profile" << gError->message;
+        g_clear_error(&gError);
+        result.clear();
+    }
+    g_markup_parse_context_free(context);
+    return result;
+}
+
+#ifndef USE_GMARKUP
+QVariantMap parseProfileXmlDom(const char *profileXml)
+{
+    QVariantMap result;
+    QDomDocument doc;
+    if (doc.setContent(QString::fromUtf8(profileXml))) {
+        QDomNodeList keys = doc.elementsByTagName("key");
+        for (int i = 0; i < keys.size(); i++) {
+            QDomElement element = keys.item(i).toElement();
+            result.insert(element.attribute("name"), element.attribute("value"));
+        }
+    }
+    return result;
+}
+#endif
+
+} // namespace transfer
+} // namespace indicator
+} // namespace unity
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2015 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Renato Araujo Oliveira Filho <renato.filho@canonical.com>
+ */
+
+
+#ifndef __BUTEO_PROFILE_H__
+#define __BUTEO_PROFILE_H__
+
+#include <QtCore/QVariantMap>
+
+namespace unity {
+namespace indicator {
+namespace transfer {
+
+// name and value of every <key> element of a Buteo profile xml,
+// empty if the xml can not be parsed
+QVariantMap parseProfileXml(const char *profileXml);
+
+// the parsers used by parseProfileXml(), the QtXml one only exists when
+// building without USE_GMARKUP
+QVariantMap parseProfileXmlGMarkup(const char *profileXml);
+#ifndef USE_GMARKUP
+QVariantMap parseProfileXmlDom(const char *profileXml);
+#endif
+
+} // namespace transfer
+} // namespace indicator
+} // namespace unity
+
+#endif
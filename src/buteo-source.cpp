@@ -19,21 +19,41 @@
 
 #include "buteo-source.h"
 #include "buteo-transfer.h"
+#include "buteo-account-transfer.h"
+#include "buteo-profile.h"
 
 #include <QtCore/QDebug>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QString>
-#include <QtDBus/QDBusReply>
-#include <QtXml/QDomDocument>
+#include <QtCore/QStringList>
+
+#include <glib/gi18n-lib.h>
+
+#include <algorithm>
 
 #define BUTEO_SERVICE_NAME  "com.meego.msyncd"
 #define BUTEO_OBJECT_PATH   "/synchronizer"
 #define BUTEO_DBUS_INTEFACE  "com.meego.msyncd"
 
+// admissions a queued sync must wait for to gain one priority level
+#define PRIORITY_AGING_STEP 2
+
+namespace {
+
+// D-Bus call made for a profile, waiting for the msyncd reply
+struct ProfileRequest
+{
+    unity::indicator::transfer::ButeoSource *source;
+    QString profileId;
+};
+
+}
+
 using namespace unity::indicator::transfer;
 
-ButeoSource::ButeoSource()
+ButeoSource::ButeoSource(bool aggregateByAccount)
     : m_cancellable(g_cancellable_new()),
+      m_aggregateByAccount(aggregateByAccount),
       m_model(std::make_shared<MutableModel>())
 {
     g_bus_get(G_BUS_TYPE_SESSION, m_cancellable,
@@ -42,6 +62,10 @@ ButeoSource::ButeoSource()
 
 ButeoSource::~ButeoSource()
 {
+    if (m_progressTimerId) {
+        g_source_remove(m_progressTimerId);
+        m_progressTimerId = 0;
+    }
     g_cancellable_cancel(m_cancellable);
     g_clear_object(&m_cancellable);
     setBus(nullptr);
@@ -61,30 +85,43 @@ void ButeoSource::open(const Transfer::Id &id)
 void ButeoSource::start(const Transfer::Id &id)
 {
     qDebug() << "start" << QString::fromStdString(id);
-    GError *gError = nullptr;
-    GVariant *reply = g_dbus_connection_call_sync(m_bus,
-                                                  BUTEO_SERVICE_NAME,
-                                                  BUTEO_OBJECT_PATH,
-                                                  BUTEO_DBUS_INTEFACE,
-                                                  "startSync",
-                                                  g_variant_new("(s)", id.c_str()),
-                                                   G_VARIANT_TYPE("(b)"),
-                                                  G_DBUS_CALL_FLAGS_NONE,
-                                                  -1,
-                                                  m_cancellable,
-                                                  &gError);
-    gboolean result = FALSE;
-    if (gError) {
-        qWarning() << "Fail to start sync" << gError->message;
-        g_error_free(gError);
-    } else {
-        g_variant_get_child(reply, 0, "b", &result);
+    QStringList profiles = transferProfiles(id);
+    if (profiles.size() > 1) {
+        std::vector<Transfer::Id> ids;
+        for (const QString &profileId : profiles) {
+            ids.push_back(profileId.toStdString());
+        }
+        startAll(ids);
+        return;
     }
-    g_clear_pointer(&reply, g_variant_unref);
 
-    if (!result) {
-        qWarning() << "Fail to start sync for profile" <<  QString::fromStdString(id);
+    QString profileId = profiles.first();
+    if (!acceptStartRequest(profileId)) {
+        return;
+    }
+
+    // there is no need to fetch the profile category if the sync can start now
+    if (connected() && m_pendingSyncs.isEmpty() && canAdmitSync()) {
+        dispatchSync(profileId);
+        return;
     }
+
+    enqueueSync(profileId);
+    admitSyncs();
+    updateQueuePositions();
+}
+
+void ButeoSource::startAll(const std::vector<Transfer::Id> &ids)
+{
+    qDebug() << "start all" << ids.size();
+    for (const Transfer::Id &id : ids) {
+        QString profileId = QString::fromStdString(id);
+        if (acceptStartRequest(profileId)) {
+            enqueueSync(profileId);
+        }
+    }
+    admitSyncs();
+    updateQueuePositions();
 }
 
 void ButeoSource::pause(const Transfer::Id &id)
@@ -101,13 +138,30 @@ void ButeoSource::resume(const Transfer::Id &id)
 
 void ButeoSource::cancel(const Transfer::Id &id)
 {
+    for (const QString &profileId : transferProfiles(id)) {
+        cancelSync(profileId);
+    }
+}
+
+void ButeoSource::cancelSync(const QString &profileId)
+{
+    // sync still waiting in the local queue, msyncd does not know about it
+    if (removePendingSync(profileId)) {
+        if (profileTransfer(profileId)) {
+            removeProfileTransfer(profileId);
+        }
+        admitSyncs();
+        updateQueuePositions();
+        return;
+    }
+
     GError *gError = nullptr;
     GVariant *reply = g_dbus_connection_call_sync(m_bus,
                                                   BUTEO_SERVICE_NAME,
                                                   BUTEO_OBJECT_PATH,
                                                   BUTEO_DBUS_INTEFACE,
                                                   "abortSync",
-                                                  g_variant_new("(s)", id.c_str()),
+                                                  g_variant_new("(s)", profileId.toUtf8().constData()),
                                                   nullptr,
                                                   G_DBUS_CALL_FLAGS_NONE,
                                                   -1,
@@ -128,6 +182,13 @@ void ButeoSource::open_app(const Transfer::Id &id)
 
 void ButeoSource::clear(const Transfer::Id &id)
 {
+    for (const QString &profileId : transferProfiles(id)) {
+        updateActiveProfile(profileId, Transfer::CANCELED);
+        if (m_aggregateByAccount) {
+            m_profileTransfers.remove(profileId);
+            m_profileAccounts.remove(profileId);
+        }
+    }
     m_model->remove(id);
 }
 
@@ -136,6 +197,66 @@ const std::shared_ptr<const MutableModel> ButeoSource::get_model()
     return m_model;
 }
 
+int ButeoSource::maxConcurrentSyncs() const
+{
+    return m_maxConcurrentSyncs;
+}
+
+void ButeoSource::setMaxConcurrentSyncs(int max)
+{
+    if (m_maxConcurrentSyncs == max) {
+        return;
+    }
+
+    m_maxConcurrentSyncs = max;
+    admitSyncs();
+    updateQueuePositions();
+}
+
+int ButeoSource::startRequestWindow() const
+{
+    return m_startRequestWindow;
+}
+
+void ButeoSource::setStartRequestWindow(int msecs)
+{
+    m_startRequestWindow = msecs;
+}
+
+int ButeoSource::suppressedStartRequests() const
+{
+    return m_suppressedStartRequests;
+}
+
+bool ButeoSource::aggregateByAccount() const
+{
+    return m_aggregateByAccount;
+}
+
+int ButeoSource::progressInterval() const
+{
+    return m_progressInterval;
+}
+
+void ButeoSource::setProgressInterval(int msecs)
+{
+    if (m_progressInterval == msecs) {
+        return;
+    }
+
+    m_progressInterval = msecs;
+    if (m_progressTimerId) {
+        g_source_remove(m_progressTimerId);
+        m_progressTimerId = 0;
+    }
+    updateTimers();
+}
+
+bool ButeoSource::timersActive() const
+{
+    return (m_progressTimerId != 0);
+}
+
 void ButeoSource::onSyncStatus(GDBusConnection* connection,
                                const gchar* senderName,
                                const gchar* objectPath,
@@ -170,24 +291,50 @@ void ButeoSource::onSyncStatus(GDBusConnection* connection,
     // if errror is a internal error ignore it,
     // this can be fired while creating the account with disabled service
     if (moreDetails == 401) {
+        if (status < 3) {
+            return;
+        }
+
+        // the sync is over, a transfer already shown must not keep running
+        std::shared_ptr<ButeoTransfer> transfer = self->profileTransfer(profileId);
+        if (transfer &&
+            ((transfer->state == Transfer::QUEUED) ||
+             (transfer->state == Transfer::RUNNING))) {
+            transfer->updateStatus(3, QString::fromUtf8(message), 0);
+            self->updateActiveProfile(profileId, transfer->state);
+            self->profileTransferChanged(profileId);
+        } else {
+            self->updateActiveProfile(profileId, Transfer::ERROR);
+        }
+        self->releaseSync(profileId);
         return;
     }
 
-    std::shared_ptr<Transfer> transfer = self->m_model->get(profileId);
+    // QUEUED or RUNNING: msyncd started by itself a sync still waiting in
+    // the local queue, it must not be started again
+    bool wasPending = (status <= 2) && self->removePendingSync(profileId);
+
+    std::shared_ptr<ButeoTransfer> transfer = self->profileTransfer(profileId);
     if (!transfer) {
-        QVariantMap fields = self->profileFields(profileId);
-        transfer = std::shared_ptr<Transfer>(new ButeoTransfer(profileId, fields));
-        self->m_model->add(transfer);
-        qDebug() << "Add new profile"
-                 << QString::fromUtf8(profileId)
-                 << QString::fromStdString(transfer->title);
+        transfer = self->ensureTransfer(profileId, self->profileFields(profileId));
     }
 
-    std::static_pointer_cast<ButeoTransfer>(transfer)->updateStatus(status, message, moreDetails);
-    self->m_model->emit_changed(transfer->id);
+    transfer->updateStatus(status, message, moreDetails);
+    self->updateActiveProfile(profileId, transfer->state);
+    self->profileTransferChanged(profileId);
+
+    if (wasPending) {
+        self->admitSyncs();
+        self->updateQueuePositions();
+    }
 
     if (transfer->state == Transfer::CANCELED) {
-        self->m_model->remove(transfer->id);
+        self->removeProfileTransfer(profileId);
+    }
+
+    // ERROR, DONE or ABORTED: the slot can be used by the next queued sync
+    if (status >= 3) {
+        self->releaseSync(profileId);
     }
 }
 
@@ -230,11 +377,18 @@ void ButeoSource::onProfileChanged(GDBusConnection* connection,
     */
 
     if (changeType == 2) {
-         std::shared_ptr<Transfer> transfer = self->m_model->get(profileId);
-         if (transfer) {
-             qDebug() << "Removing transfer:" << transfer->id.c_str();
-             self->clear(transfer->id);
+         self->removePendingSync(profileId);
+
+         if (self->profileTransfer(profileId)) {
+             qDebug() << "Removing transfer:" << profileId;
+             self->removeProfileTransfer(profileId);
          }
+
+         self->m_lastStartRequest.remove(profileId);
+         ButeoTransfer::clearHistory(profileId);
+         self->releaseSync(profileId);
+         self->admitSyncs();
+         self->updateQueuePositions();
     }
 }
 
@@ -249,6 +403,8 @@ void ButeoSource::setBus(GDBusConnection *bus)
         m_syncStatusId = 0;
         g_dbus_connection_signal_unsubscribe(m_bus, m_profileChangedId);
         m_profileChangedId = 0;
+        g_bus_unwatch_name(m_serviceWatcherId);
+        m_serviceWatcherId = 0;
         m_model.reset();
         g_object_unref(m_bus);
         m_bus = nullptr;
@@ -277,6 +433,19 @@ void ButeoSource::setBus(GDBusConnection *bus)
                                                             (GDBusSignalCallback) onProfileChanged,
                                                             this,
                                                             nullptr);
+
+        m_serviceWatcherId = g_bus_watch_name_on_connection(m_bus,
+                                                            BUTEO_SERVICE_NAME,
+                                                            G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                            nullptr,
+                                                            (GBusNameVanishedCallback) onServiceVanished,
+                                                            this,
+                                                            nullptr);
+
+        // syncs requested before the bus was ready have no profile fields
+        for (const PendingSync &pending : m_pendingSyncs) {
+            fetchProfileFields(pending.profileId);
+        }
     }
 }
 
@@ -301,6 +470,9 @@ void ButeoSource::onBusReady(GObject *object, GAsyncResult *res, ButeoSource *se
 QVariantMap ButeoSource::profileFields(const QString &profileId) const
 {
     QVariantMap result;
+    if (!m_bus) {
+        return result;
+    }
 
     GError *gError = nullptr;
     GVariant *reply = g_dbus_connection_call_sync(m_bus,
@@ -323,17 +495,465 @@ QVariantMap ButeoSource::profileFields(const QString &profileId) const
 
     const gchar* profileXml = nullptr;
     g_variant_get_child(reply, 0, "&s", &profileXml);
+    result = parseProfileXml(profileXml);
+
+    g_clear_pointer(&reply, g_variant_unref);
+    return result;
+}
 
-    // parse Xml
-    QDomDocument doc;
-    if (doc.setContent(QString::fromUtf8(profileXml))) {
-        QDomNodeList keys = doc.elementsByTagName("key");
-        for (int i = 0; i < keys.size(); i++) {
-            QDomElement element = keys.item(i).toElement();
-            result.insert(element.attribute("name"), element.attribute("value"));
+void ButeoSource::fetchProfileFields(const QString &profileId)
+{
+    ProfileRequest *request = new ProfileRequest;
+    request->source = this;
+    request->profileId = profileId;
+    g_dbus_connection_call(m_bus,
+                           BUTEO_SERVICE_NAME,
+                           BUTEO_OBJECT_PATH,
+                           BUTEO_DBUS_INTEFACE,
+                           "syncProfile",
+                           g_variant_new("(s)", profileId.toUtf8().constData()),
+                           G_VARIANT_TYPE("(s)"),
+                           G_DBUS_CALL_FLAGS_NONE,
+                           -1,
+                           m_cancellable,
+                           (GAsyncReadyCallback) onProfileFieldsReply,
+                           request);
+}
+
+void ButeoSource::onProfileFieldsReply(GObject *object, GAsyncResult *res, gpointer userData)
+{
+    ProfileRequest *request = static_cast<ProfileRequest*>(userData);
+    GError *gError = nullptr;
+    GVariant *reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object), res, &gError);
+
+    if (gError) {
+        // the source was destroyed
+        if (g_error_matches(gError, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free(gError);
+            delete request;
+            return;
         }
+        qWarning() << "Failt to retrieve profile" << request->profileId << gError->message;
+        g_error_free(gError);
     }
 
+    QVariantMap fields;
+    if (reply) {
+        const gchar* profileXml = nullptr;
+        g_variant_get_child(reply, 0, "&s", &profileXml);
+        fields = parseProfileXml(profileXml);
+        g_variant_unref(reply);
+    }
+
+    // the sync may have been canceled meanwhile
+    ButeoSource *self = request->source;
+    for (int i = 0; i < self->m_pendingSyncs.size(); i++) {
+        PendingSync &pending = self->m_pendingSyncs[i];
+        if ((pending.profileId == request->profileId) && !pending.resolved) {
+            pending.fields = fields;
+            pending.priority = categoryPriority(fields.value("category", "contacts").toString());
+            pending.resolved = true;
+
+            self->sortPendingSyncs();
+            self->admitSyncs();
+            self->updateQueuePositions();
+            break;
+        }
+    }
+    delete request;
+}
+
+std::shared_ptr<ButeoTransfer> ButeoSource::profileTransfer(const QString &profileId) const
+{
+    if (m_aggregateByAccount) {
+        return m_profileTransfers.value(profileId);
+    }
+    return std::static_pointer_cast<ButeoTransfer>(m_model->get(profileId.toStdString()));
+}
+
+std::shared_ptr<ButeoTransfer> ButeoSource::ensureTransfer(const QString &profileId,
+                                                           const QVariantMap &fields)
+{
+    std::shared_ptr<ButeoTransfer> transfer = profileTransfer(profileId);
+    if (transfer) {
+        return transfer;
+    }
+
+    if (!m_aggregateByAccount) {
+        transfer = std::shared_ptr<ButeoTransfer>(new ButeoTransfer(profileId, fields));
+        m_model->add(transfer);
+        qDebug() << "Add new profile"
+                 << profileId
+                 << QString::fromStdString(transfer->title);
+        return transfer;
+    }
+
+    // profiles without account are not grouped
+    int accountId = fields.value("accountid", 0).toInt();
+    QString accountTransferId = profileId;
+    if (accountId > 0) {
+        accountTransferId = QString("account-%1").arg(accountId);
+    }
+
+    // the account info is only used by the aggregate transfer
+    QVariantMap memberFields(fields);
+    memberFields.remove("accountid");
+    transfer = std::shared_ptr<ButeoTransfer>(new ButeoTransfer(profileId, memberFields));
+    m_profileTransfers.insert(profileId, transfer);
+    m_profileAccounts.insert(profileId, accountTransferId);
+
+    std::shared_ptr<ButeoAccountTransfer> accountTransfer =
+        std::dynamic_pointer_cast<ButeoAccountTransfer>(m_model->get(accountTransferId.toStdString()));
+    if (accountTransfer) {
+        accountTransfer->addProfile(transfer);
+        if (accountTransfer->refresh()) {
+            m_model->emit_changed(accountTransfer->id);
+        }
+    } else {
+        accountTransfer = std::shared_ptr<ButeoAccountTransfer>(new ButeoAccountTransfer(accountTransferId, fields));
+        accountTransfer->addProfile(transfer);
+        accountTransfer->refresh();
+        m_model->add(accountTransfer);
+        qDebug() << "Add new account"
+                 << accountTransferId
+                 << QString::fromStdString(accountTransfer->title);
+    }
+    return transfer;
+}
+
+void ButeoSource::profileTransferChanged(const QString &profileId)
+{
+    if (!m_aggregateByAccount) {
+        m_model->emit_changed(profileId.toStdString());
+        return;
+    }
+
+    // only notify if the aggregate has changed
+    std::shared_ptr<ButeoAccountTransfer> accountTransfer =
+        std::dynamic_pointer_cast<ButeoAccountTransfer>(m_model->get(m_profileAccounts.value(profileId).toStdString()));
+    if (accountTransfer && accountTransfer->refresh()) {
+        m_model->emit_changed(accountTransfer->id);
+    }
+}
+
+void ButeoSource::removeProfileTransfer(const QString &profileId)
+{
+    updateActiveProfile(profileId, Transfer::CANCELED);
+    if (!m_aggregateByAccount) {
+        m_model->remove(profileId.toStdString());
+        return;
+    }
+
+    m_profileTransfers.remove(profileId);
+    QString accountTransferId = m_profileAccounts.take(profileId);
+    std::shared_ptr<ButeoAccountTransfer> accountTransfer =
+        std::dynamic_pointer_cast<ButeoAccountTransfer>(m_model->get(accountTransferId.toStdString()));
+    if (!accountTransfer) {
+        return;
+    }
+
+    accountTransfer->removeProfile(profileId);
+    if (accountTransfer->isEmpty()) {
+        m_model->remove(accountTransfer->id);
+    } else if (accountTransfer->refresh()) {
+        m_model->emit_changed(accountTransfer->id);
+    }
+}
+
+QStringList ButeoSource::transferProfiles(const Transfer::Id &id) const
+{
+    if (m_aggregateByAccount) {
+        std::shared_ptr<ButeoAccountTransfer> accountTransfer =
+            std::dynamic_pointer_cast<ButeoAccountTransfer>(m_model->get(id));
+        if (accountTransfer) {
+            return accountTransfer->profiles();
+        }
+    }
+    return QStringList() << QString::fromStdString(id);
+}
+
+bool ButeoSource::acceptStartRequest(const QString &profileId)
+{
+    bool active = m_startsInFlight.contains(profileId);
+    if (!active) {
+        std::shared_ptr<ButeoTransfer> transfer = profileTransfer(profileId);
+        active = transfer &&
+                 ((transfer->state == Transfer::QUEUED) ||
+                  (transfer->state == Transfer::RUNNING));
+    }
+
+    gint64 now = g_get_monotonic_time();
+    if (!active && m_lastStartRequest.contains(profileId)) {
+        gint64 elapsed = (now - m_lastStartRequest.value(profileId)) / 1000;
+        active = (elapsed < m_startRequestWindow);
+    }
+
+    if (active) {
+        qDebug() << "Ignoring repeated start request for profile" << profileId;
+        m_suppressedStartRequests++;
+        return false;
+    }
+
+    m_lastStartRequest.insert(profileId, now);
+    return true;
+}
+
+void ButeoSource::enqueueSync(const QString &profileId)
+{
+    // already sent to msyncd, let it report the current state again
+    if (m_admittedSyncs.contains(profileId)) {
+        dispatchSync(profileId);
+        return;
+    }
+
+    for (const PendingSync &pending : m_pendingSyncs) {
+        if (pending.profileId == profileId) {
+            return;
+        }
+    }
+
+    // the category is only known once msyncd replies with the profile,
+    // until then the sync has the lowest priority
+    PendingSync pending;
+    pending.profileId = profileId;
+    pending.resolved = false;
+    pending.priority = categoryPriority(QString());
+    pending.turn = m_admissions;
+    m_pendingSyncs.append(pending);
+
+    if (connected()) {
+        fetchProfileFields(profileId);
+    }
+}
+
+void ButeoSource::sortPendingSyncs()
+{
+    // a sync requested PRIORITY_AGING_STEP admissions later does not pass
+    // a sync of the next priority level, so contacts can not starve the
+    // other categories; std::stable_sort keeps the request order on ties
+    std::stable_sort(m_pendingSyncs.begin(), m_pendingSyncs.end(),
+                     [](const PendingSync &a, const PendingSync &b) {
+                         return ((a.priority * PRIORITY_AGING_STEP) + a.turn) <
+                                ((b.priority * PRIORITY_AGING_STEP) + b.turn);
+                     });
+}
+
+bool ButeoSource::removePendingSync(const QString &profileId)
+{
+    for (int i = 0; i < m_pendingSyncs.size(); i++) {
+        if (m_pendingSyncs.at(i).profileId == profileId) {
+            m_pendingSyncs.removeAt(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ButeoSource::fetchingProfiles() const
+{
+    for (const PendingSync &pending : m_pendingSyncs) {
+        if (!pending.resolved) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ButeoSource::canAdmitSync() const
+{
+    return (m_maxConcurrentSyncs <= 0) ||
+           (m_admittedSyncs.size() < m_maxConcurrentSyncs);
+}
+
+void ButeoSource::admitSyncs()
+{
+    // wait for the categories of all requested profiles before choosing
+    if (!connected() || fetchingProfiles()) {
+        return;
+    }
+
+    while (!m_pendingSyncs.isEmpty() && canAdmitSync()) {
+        QString profileId = m_pendingSyncs.takeFirst().profileId;
+        m_admissions++;
+
+        // the sync is no longer waiting in the local queue
+        std::shared_ptr<ButeoTransfer> transfer = profileTransfer(profileId);
+        if (transfer) {
+            transfer->setQueuePosition(0);
+            profileTransferChanged(profileId);
+        }
+        dispatchSync(profileId);
+    }
+}
+
+void ButeoSource::dispatchSync(const QString &profileId)
+{
+    qDebug() << "Dispatch sync" << profileId;
+    m_admittedSyncs.insert(profileId);
+    m_startsInFlight.insert(profileId);
+
+    ProfileRequest *request = new ProfileRequest;
+    request->source = this;
+    request->profileId = profileId;
+    g_dbus_connection_call(m_bus,
+                           BUTEO_SERVICE_NAME,
+                           BUTEO_OBJECT_PATH,
+                           BUTEO_DBUS_INTEFACE,
+                           "startSync",
+                           g_variant_new("(s)", profileId.toUtf8().constData()),
+                           G_VARIANT_TYPE("(b)"),
+                           G_DBUS_CALL_FLAGS_NONE,
+                           -1,
+                           m_cancellable,
+                           (GAsyncReadyCallback) onStartSyncReply,
+                           request);
+}
+
+void ButeoSource::releaseSync(const QString &profileId)
+{
+    if (m_admittedSyncs.remove(profileId)) {
+        admitSyncs();
+        updateQueuePositions();
+    }
+}
+
+void ButeoSource::updateQueuePositions()
+{
+    if (!connected()) {
+        return;
+    }
+
+    // profiles without fields yet are listed once msyncd replies
+    int position = 0;
+    for (const PendingSync &pending : m_pendingSyncs) {
+        if (!pending.resolved) {
+            continue;
+        }
+
+        std::shared_ptr<ButeoTransfer> transfer = ensureTransfer(pending.profileId, pending.fields);
+        Transfer::State oldState = transfer->state;
+        std::string oldCustomState = transfer->custom_state;
+
+        transfer->setQueuePosition(++position);
+        if ((oldState != transfer->state) || (oldCustomState != transfer->custom_state)) {
+            profileTransferChanged(pending.profileId);
+        }
+    }
+}
+
+void ButeoSource::updateActiveProfile(const QString &profileId, Transfer::State state)
+{
+    if ((state == Transfer::QUEUED) || (state == Transfer::RUNNING)) {
+        m_activeProfiles.insert(profileId);
+    } else {
+        m_activeProfiles.remove(profileId);
+    }
+
+    if (state == Transfer::RUNNING) {
+        m_runningProfiles.insert(profileId);
+    } else {
+        m_runningProfiles.remove(profileId);
+    }
+
+    updateTimers();
+}
+
+void ButeoSource::updateTimers()
+{
+    // timers only exist while a sync is running, an idle source must not
+    // wake up the main loop
+    bool running = !m_runningProfiles.isEmpty() && (m_progressInterval > 0);
+    if (running && (m_progressTimerId == 0)) {
+        m_progressTimerId = g_timeout_add(m_progressInterval,
+                                          (GSourceFunc) onProgressTimeout,
+                                          this);
+    } else if (!running && (m_progressTimerId != 0)) {
+        g_source_remove(m_progressTimerId);
+        m_progressTimerId = 0;
+    }
+}
+
+gboolean ButeoSource::onProgressTimeout(ButeoSource *self)
+{
+    gint64 now = g_get_monotonic_time();
+    const QSet<QString> runningProfiles = self->m_runningProfiles;
+    for (const QString &profileId : runningProfiles) {
+        std::shared_ptr<ButeoTransfer> transfer = self->profileTransfer(profileId);
+        if (transfer && transfer->interpolateProgress(now)) {
+            self->profileTransferChanged(profileId);
+        }
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+int ButeoSource::categoryPriority(const QString &category)
+{
+    // contacts are the data most visible for the user, sync it first
+    static const QStringList priorities = QStringList() << "contacts" << "calendar";
+    int index = priorities.indexOf(category);
+    return (index >= 0) ? index : priorities.size();
+}
+
+void ButeoSource::onStartSyncReply(GObject *object, GAsyncResult *res, gpointer userData)
+{
+    ProfileRequest *request = static_cast<ProfileRequest*>(userData);
+    GError *gError = nullptr;
+    GVariant *reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object), res, &gError);
+
+    gboolean result = FALSE;
+    QString errorMessage(_("Fail to start sync"));
+    if (gError) {
+        // the source was destroyed
+        if (g_error_matches(gError, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free(gError);
+            delete request;
+            return;
+        }
+        qWarning() << "Fail to start sync" << gError->message;
+        errorMessage = QString::fromUtf8(gError->message);
+        g_error_free(gError);
+    } else {
+        g_variant_get_child(reply, 0, "b", &result);
+    }
     g_clear_pointer(&reply, g_variant_unref);
-    return result;
+
+    request->source->m_startsInFlight.remove(request->profileId);
+    if (!result) {
+        qWarning() << "Fail to start sync for profile" << request->profileId;
+
+        // msyncd will not report anything about it
+        std::shared_ptr<ButeoTransfer> transfer = request->source->profileTransfer(request->profileId);
+        if (transfer && (transfer->state == Transfer::QUEUED)) {
+            transfer->updateStatus(3, errorMessage, 0);
+            request->source->updateActiveProfile(request->profileId, transfer->state);
+            request->source->profileTransferChanged(request->profileId);
+        }
+        request->source->releaseSync(request->profileId);
+    }
+    delete request;
+}
+
+void ButeoSource::onServiceVanished(GDBusConnection *connection,
+                                    const gchar *name,
+                                    ButeoSource *self)
+{
+    Q_UNUSED(connection);
+    qWarning() << "Sync service vanished" << name;
+
+    // msyncd will not report the end of the syncs it was running
+    const QSet<QString> activeProfiles = self->m_activeProfiles;
+    for (const QString &profileId : activeProfiles) {
+        std::shared_ptr<ButeoTransfer> transfer = self->profileTransfer(profileId);
+        if (transfer) {
+            transfer->updateStatus(3, QString(_("Sync service stopped")), 0);
+            self->updateActiveProfile(profileId, transfer->state);
+            self->profileTransferChanged(profileId);
+        }
+    }
+
+    self->m_startsInFlight.clear();
+    const QSet<QString> admittedSyncs = self->m_admittedSyncs;
+    for (const QString &profileId : admittedSyncs) {
+        self->releaseSync(profileId);
+    }
 }
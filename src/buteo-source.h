@@ -18,13 +18,17 @@
  */
 
 #include <memory>
+#include <vector>
 #include <indicator-transfer/transfer/source.h>
 
 #include <QtCore/QMap>
+#include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QScopedPointer>
-#include <QtDBus/QDBusInterface>
-#include <QtDBus/QDBusServiceWatcher>
+
+#include <gio/gio.h>
 
 namespace unity {
 namespace indicator {
@@ -35,12 +39,15 @@ class ButeoTransfer;
 class ButeoSource : public Source
 {
 public:
-    ButeoSource();
+    // aggregateByAccount groups the profiles of each account in a single
+    // transfer
+    explicit ButeoSource(bool aggregateByAccount = false);
     ~ButeoSource();
 
     bool connected() const;
     void open(const Transfer::Id& id) override;
     void start(const Transfer::Id& id) override;
+    void startAll(const std::vector<Transfer::Id>& ids);
     void pause(const Transfer::Id& id) override;
     void resume(const Transfer::Id& id) override;
     void cancel(const Transfer::Id& id) override;
@@ -49,19 +56,103 @@ public:
 
     const std::shared_ptr<const MutableModel> get_model() override;
 
+    // max number of syncs started by this source running at same time,
+    // 0 means no limit
+    int maxConcurrentSyncs() const;
+    void setMaxConcurrentSyncs(int max);
+
+    // repeated start requests for the same profile inside this interval
+    // (in milliseconds) are ignored
+    int startRequestWindow() const;
+    void setStartRequestWindow(int msecs);
+    int suppressedStartRequests() const;
+
+    bool aggregateByAccount() const;
+
+    // interval (in milliseconds) used to update the estimated progress
+    // of running syncs, 0 disables the estimation
+    int progressInterval() const;
+    void setProgressInterval(int msecs);
+
+    // true while any timer is scheduled, only happens when a sync is running
+    bool timersActive() const;
+
 private:
+    struct PendingSync
+    {
+        QString profileId;
+        QVariantMap fields;
+        // false until msyncd replied with the profile fields
+        bool resolved;
+        int priority;
+        // admissions made before the request, ages the priority
+        int turn;
+    };
+
     GCancellable *m_cancellable;
     GDBusConnection *m_bus = nullptr;
     guint m_syncStatusId = 0;
     guint m_profileChangedId = 0;
+    guint m_serviceWatcherId = 0;
+    int m_maxConcurrentSyncs = 2;
+    int m_startRequestWindow = 1000;
+    int m_suppressedStartRequests = 0;
+    const bool m_aggregateByAccount;
+    int m_progressInterval = 250;
+    int m_admissions = 0;
+    guint m_progressTimerId = 0;
 
     std::shared_ptr<MutableModel> m_model;
+    // syncs waiting for a free slot, ordered by aged category priority
+    QList<PendingSync> m_pendingSyncs;
+    // syncs requested by this source and not finished yet
+    QSet<QString> m_admittedSyncs;
+    // startSync calls waiting for msyncd reply
+    QSet<QString> m_startsInFlight;
+    // monotonic time of the last accepted start request
+    QMap<QString, gint64> m_lastStartRequest;
+    // per profile transfers and the model transfer that groups them,
+    // used when aggregating by account
+    QMap<QString, std::shared_ptr<ButeoTransfer> > m_profileTransfers;
+    QMap<QString, QString> m_profileAccounts;
+    // profiles reported as QUEUED or RUNNING by msyncd
+    QSet<QString> m_activeProfiles;
+    // profiles with a running sync, used to estimate the progress
+    QSet<QString> m_runningProfiles;
 
     void setBus(GDBusConnection *bus);
 
     QVariantMap profileFields(const QString &profileId) const;
+    void fetchProfileFields(const QString &profileId);
+    std::shared_ptr<ButeoTransfer> profileTransfer(const QString &profileId) const;
+    std::shared_ptr<ButeoTransfer> ensureTransfer(const QString &profileId,
+                                                  const QVariantMap &fields);
+    void profileTransferChanged(const QString &profileId);
+    void removeProfileTransfer(const QString &profileId);
+    QStringList transferProfiles(const Transfer::Id &id) const;
+
+    bool acceptStartRequest(const QString &profileId);
+    void enqueueSync(const QString &profileId);
+    void sortPendingSyncs();
+    bool removePendingSync(const QString &profileId);
+    bool fetchingProfiles() const;
+    void admitSyncs();
+    void dispatchSync(const QString &profileId);
+    void cancelSync(const QString &profileId);
+    void releaseSync(const QString &profileId);
+    void updateQueuePositions();
+    bool canAdmitSync() const;
+    void updateActiveProfile(const QString &profileId, Transfer::State state);
+    void updateTimers();
 
+    static int categoryPriority(const QString &category);
     static void onBusReady(GObject *object, GAsyncResult *res, ButeoSource *self);
+    static void onStartSyncReply(GObject *object, GAsyncResult *res, gpointer userData);
+    static void onProfileFieldsReply(GObject *object, GAsyncResult *res, gpointer userData);
+    static gboolean onProgressTimeout(ButeoSource *self);
+    static void onServiceVanished(GDBusConnection *connection,
+                                  const gchar *name,
+                                  ButeoSource *self);
     static void onSyncStatus(GDBusConnection* connection,
                              const gchar* senderName,
                              const gchar* objectPath,
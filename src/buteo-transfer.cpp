@@ -31,8 +31,24 @@
 
 #include <glib/gi18n-lib.h>
 
+// the estimated progress never reaches the end of the current phase
+#define PROGRESS_CEILING_MARGIN     0.01
+// smaller estimated changes are not notified
+#define PROGRESS_INTERPOLATION_STEP 0.01
+
 using namespace unity::indicator::transfer;
 
+namespace {
+
+// duration of the last successful sync of each profile
+QMap<std::string, gint64> &syncDurations()
+{
+    static QMap<std::string, gint64> durations;
+    return durations;
+}
+
+}
+
 ButeoTransfer::ButeoTransfer(const QString &profileId,
                              const QVariantMap &fields)
 {
@@ -103,6 +119,9 @@ void ButeoTransfer::updateStatus(int status, const QString &message, int moreDet
         break;
     case 1:
     case 2:
+        if (state != Transfer::RUNNING) {
+            m_syncStartTime = g_get_monotonic_time();
+        }
         state = Transfer::RUNNING;
         updateProgress(moreDetails);
         break;
@@ -112,6 +131,10 @@ void ButeoTransfer::updateStatus(int status, const QString &message, int moreDet
         break;
     case 4:
         state = Transfer::FINISHED;
+        if (m_syncStartTime > 0) {
+            syncDurations().insert(id, g_get_monotonic_time() - m_syncStartTime);
+            m_syncStartTime = 0;
+        }
         break;
     case 5:
         state = Transfer::CANCELED;
@@ -125,11 +148,30 @@ void ButeoTransfer::updateStatus(int status, const QString &message, int moreDet
     }
 }
 
+void ButeoTransfer::setQueuePosition(int position)
+{
+    // position inside the local admission queue, the sync was not sent to
+    // msyncd yet
+    state = Transfer::QUEUED;
+    reset();
+    if (position > 0) {
+        custom_state = QString(_("Waiting (%1)")).arg(position).toStdString();
+    } else {
+        custom_state = "";
+    }
+}
+
 void ButeoTransfer::reset()
 {
     m_state = 0;
     progress = 0.0;
     error_string = "";
+
+    m_syncStartTime = 0;
+    m_lastUpdateTime = 0;
+    m_reportedProgress = 0.0;
+    m_phaseRate = 0.0;
+    m_ratePhase = 0;
 }
 
 void ButeoTransfer::updateProgress(int progress)
@@ -163,11 +205,86 @@ void ButeoTransfer::updateProgress(int progress)
         break;
     }
 
+    qreal reportedProgress = 0.0;
     if (realProgress > 0) {
-        this->progress = (realProgress / 200.0);
-    } else {
-        this->progress = 0.0;
+        reportedProgress = (realProgress / 200.0);
+    }
+
+    // progress rate observed inside the current phase
+    gint64 now = g_get_monotonic_time();
+    if (m_ratePhase != m_state) {
+        m_ratePhase = m_state;
+        m_phaseRate = 0.0;
+    } else if ((m_lastUpdateTime > 0) &&
+               (now > m_lastUpdateTime) &&
+               (reportedProgress > m_reportedProgress)) {
+        m_phaseRate = (reportedProgress - m_reportedProgress) * G_USEC_PER_SEC /
+                      (now - m_lastUpdateTime);
+    }
+    m_reportedProgress = reportedProgress;
+    m_lastUpdateTime = now;
+
+    // the estimated progress can be ahead of the reported one
+    this->progress = qMax<qreal>(this->progress, reportedProgress);
+}
+
+qreal ButeoTransfer::phaseCeiling() const
+{
+    switch(m_state) {
+    case 201: //SYNC_PROGRESS_INITIALISING
+        // receiving can follow and starts at the very beginning, an estimate
+        // would run ahead of it and then freeze the progress
+        return 1.0 / 200.0;
+    case 203: //SYNC_PROGRESS_RECEIVING_ITEMS
+        return 0.5;
+    default:
+        return 1.0;
+    }
+}
+
+bool ButeoTransfer::interpolateProgress(gint64 now)
+{
+    if ((state != Transfer::RUNNING) || (m_lastUpdateTime == 0)) {
+        return false;
+    }
+
+    qreal rate = m_phaseRate;
+    if (rate <= 0.0) {
+        // nothing observed in this phase yet, use the last sync duration
+        gint64 duration = syncDurations().value(id, 0);
+        if (duration > 0) {
+            rate = qreal(G_USEC_PER_SEC) / duration;
+        }
+    }
+
+    if (rate <= 0.0) {
+        return false;
     }
+
+    qreal elapsed = qreal(now - m_lastUpdateTime) / G_USEC_PER_SEC;
+    qreal estimated = qMin(m_reportedProgress + (rate * elapsed),
+                           phaseCeiling() - PROGRESS_CEILING_MARGIN);
+    if ((estimated - progress) < PROGRESS_INTERPOLATION_STEP) {
+        return false;
+    }
+
+    progress = estimated;
+    return true;
+}
+
+gint64 ButeoTransfer::lastSyncDuration() const
+{
+    return syncDurations().value(id, 0);
+}
+
+void ButeoTransfer::clearHistory(const QString &profileId)
+{
+    syncDurations().remove(profileId.toStdString());
+}
+
+QString ButeoTransfer::category() const
+{
+    return m_category;
 }
 
 bool ButeoTransfer::can_start() const
@@ -17,6 +17,9 @@
  *   Renato Araujo Oliveira Filho <renato.filho@canonical.com>
  */
 
+#ifndef __BUTEO_TRANSFER_H__
+#define __BUTEO_TRANSFER_H__
+
 #include <indicator-transfer/transfer/transfer.h>
 #include <memory>
 
@@ -24,6 +27,8 @@
 #include <QtCore/QVariant>
 #include <QtCore/QMap>
 
+#include <glib.h>
+
 namespace unity {
 namespace indicator {
 namespace transfer {
@@ -35,8 +40,19 @@ public:
                   const QVariantMap &fields);
     void launchApp() const;
     void updateStatus(int status, const QString &message, int moreDetails);
+    void setQueuePosition(int position);
     void reset();
 
+    QString category() const;
+
+    // estimate the progress between msyncd updates,
+    // returns true if the progress has changed
+    bool interpolateProgress(gint64 now);
+    // duration (in microseconds) of the last successful sync, 0 if unknown
+    gint64 lastSyncDuration() const;
+    // forget the sync history of a deleted profile
+    static void clearHistory(const QString &profileId);
+
     bool can_pause() const override;
     bool can_start() const override;
 
@@ -45,9 +61,19 @@ private:
     QString m_appUrl;
     int m_state = 0;
 
+    // progress estimation
+    gint64 m_syncStartTime = 0;
+    gint64 m_lastUpdateTime = 0;
+    qreal m_reportedProgress = 0.0;
+    qreal m_phaseRate = 0.0;
+    int m_ratePhase = 0;
+
     void updateProgress(int progress);
+    qreal phaseCeiling() const;
 };
 
 } // namespace transfer
 } // namespace indicator
 } // namespace unity
+
+#endif
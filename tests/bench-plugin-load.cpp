@@ -0,0 +1,159 @@
+/*
+ * Copyright 2015 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Measures the time from loading the plugin until its model is ready and
+// the resident memory used by the plugin.
+//
+// "model-ready" is the first transfer added to the model after a single
+// start() call made right after loading: it covers the plugin load, the
+// session bus connection, the profile fetch, startSync and the first
+// status signal. A single sync never waits for a free slot, so the
+// admission queue is not measured. The mock runs at BENCH_TIME_SCALE of
+// its real timings, so neither is its fake sync delay.
+
+#include <indicator-transfer/transfer/source.h>
+
+#include <gio/gio.h>
+#include <gmodule.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+#define BENCH_PROFILE     "bench-profile"
+#define BENCH_TIMEOUT     10
+#define BENCH_TIME_SCALE  0.001
+
+using namespace unity::indicator::transfer;
+
+typedef Source* (*GetSourceFunc)();
+
+static long residentSetSize()
+{
+    long size = 0;
+    long resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(statm);
+    }
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+// uses its own connection, the plugin must still set up the shared one
+static void setMockTimeScale(gdouble scale)
+{
+    GError *error = nullptr;
+    gchar *address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SESSION, nullptr, &error);
+    GDBusConnection *bus = nullptr;
+    if (address) {
+        bus = g_dbus_connection_new_for_address_sync(address,
+                                                     (GDBusConnectionFlags) (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                                                             G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+                                                     nullptr,
+                                                     nullptr,
+                                                     &error);
+        g_free(address);
+    }
+
+    if (bus) {
+        GVariant *reply = g_dbus_connection_call_sync(bus,
+                                                      "com.meego.msyncd",
+                                                      "/synchronizer",
+                                                      "com.meego.msyncd.Mock",
+                                                      "setTimeScale",
+                                                      g_variant_new("(d)", scale),
+                                                      nullptr,
+                                                      G_DBUS_CALL_FLAGS_NONE,
+                                                      -1,
+                                                      nullptr,
+                                                      &error);
+        g_clear_pointer(&reply, g_variant_unref);
+        g_dbus_connection_close_sync(bus, nullptr, nullptr);
+        g_object_unref(bus);
+    }
+
+    if (error) {
+        g_warning("Fail to set the mock time scale: %s", error->message);
+        g_error_free(error);
+    }
+}
+
+static gboolean onTimeout(GMainLoop *loop)
+{
+    g_warning("Timeout waiting for the model");
+    g_main_loop_quit(loop);
+    return G_SOURCE_REMOVE;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        g_printerr("Usage: %s <plugin>\n", argv[0]);
+        return 1;
+    }
+
+    setMockTimeScale(BENCH_TIME_SCALE);
+
+    GMainLoop *loop = g_main_loop_new(nullptr, FALSE);
+    long rssBefore = residentSetSize();
+    gint64 begin = g_get_monotonic_time();
+
+    GModule *module = g_module_open(argv[1], G_MODULE_BIND_LAZY);
+    if (!module) {
+        g_printerr("Fail to load plugin: %s\n", g_module_error());
+        return 1;
+    }
+
+    gpointer symbol = nullptr;
+    if (!g_module_symbol(module, "get_source", &symbol)) {
+        g_printerr("Fail to find get_source: %s\n", g_module_error());
+        return 1;
+    }
+
+    Source *source = reinterpret_cast<GetSourceFunc>(symbol)();
+    gint64 ready = 0;
+    source->get_model()->added().connect([&ready, loop](const Transfer::Id &id){
+        (void) id;
+        if (ready == 0) {
+            ready = g_get_monotonic_time();
+            g_main_loop_quit(loop);
+        }
+    });
+
+    source->start(BENCH_PROFILE);
+
+    guint timeoutId = g_timeout_add_seconds(BENCH_TIMEOUT, (GSourceFunc) onTimeout, loop);
+    g_main_loop_run(loop);
+    if (ready > 0) {
+        g_source_remove(timeoutId);
+    }
+    long rssAfter = residentSetSize();
+
+    int result = 1;
+    if (ready > 0) {
+        g_print("plugin: %s\n", argv[1]);
+        g_print("load-to-model-ready: %.3f ms\n", (ready - begin) / 1000.0);
+        g_print("rss-delta: %ld kB\n", rssAfter - rssBefore);
+        result = 0;
+    }
+
+    delete source;
+    g_main_loop_unref(loop);
+    setMockTimeScale(1.0);
+    return result;
+}
@@ -34,14 +34,15 @@ from gi.repository import GObject
 BUS_NAME = 'com.meego.msyncd'
 MAIN_OBJ = '/synchronizer'
 MAIN_IFACE = 'com.meego.msyncd'
+MOCK_IFACE = 'com.meego.msyncd.Mock'
 SYSTEM_BUS = False
 
 class ButeoSyncFw(dbus.service.Object):
-    PROFILES = [
+    PROFILE_TEMPLATE = \
 """<?xml version=\"1.0\" encoding=\"UTF-8\"?>
-<profile type=\"sync\" name=\"test-profile\">
+<profile type=\"sync\" name=\"%(name)s\">
     <key value=\"45\" name=\"accountid\"/>
-    <key value=\"contacts\" name=\"category\"/>
+    <key value=\"%(category)s\" name=\"category\"/>
     <key value=\"google-contacts-ubuntu@gmail.com\" name=\"displayname\"/>
     <key value=\"true\" name=\"enabled\"/>
     <key value=\"google-contacts\" name=\"remote_service_name\"/>
@@ -55,25 +56,36 @@ class ButeoSyncFw(dbus.service.Object):
         <rush end=\"\" externalsync=\"false\" days=\"\" interval=\"15\" begin=\"\" enabled=\"false\"/>
     </schedule>
 </profile>
-"""]
+"""
 
     def __init__(self, object_path):
         dbus.service.Object.__init__(self, dbus.SessionBus(), object_path)
         self._activeSync = []
-        self._profiles = ButeoSyncFw.PROFILES
+        self._timers = {}
+        self._timeScale = 1.0
+
+    def profileXml(self, profileId):
+        # profiles named as "<category>-..." use that category
+        category = 'contacts'
+        if profileId.startswith('calendar'):
+            category = 'calendar'
+        return ButeoSyncFw.PROFILE_TEMPLATE % {'name': profileId,
+                                               'category': category}
 
     @dbus.service.method(dbus_interface=MAIN_IFACE,
                          in_signature='s', out_signature='')
     def abortSync(self, profileId):
+        self.stopSync(profileId)
         self.syncStatus(profileId, 5, 'aborted by the user', 0)
 
     @dbus.service.method(dbus_interface=MAIN_IFACE,
                          in_signature='s', out_signature='b')
     def startSync(self, profileId):
-        GObject.timeout_add(200, self.notifySyncQueued, profileId)
-        GObject.timeout_add(400, self.notifySyncStarted, profileId)
-        GObject.timeout_add(600, self.notifySyncProgress, profileId)
-        GObject.timeout_add(800, self.notifySyncFinished, profileId)
+        # profiles named as "rejected-..." can not be started
+        if profileId.startswith('rejected'):
+            return False
+        self.runSync(profileId)
+        return True
 
     @dbus.service.method(dbus_interface=MAIN_IFACE,
                          in_signature='', out_signature='as')
@@ -81,15 +93,87 @@ class ButeoSyncFw(dbus.service.Object):
         return self._activeSync
 
     @dbus.service.method(dbus_interface=MAIN_IFACE,
-                         in_signature='', out_signature='s')
+                         in_signature='s', out_signature='s')
     def syncProfile(self, profileId):
-        return self._profiles[0]
+        return self.profileXml(profileId)
 
     @dbus.service.signal(dbus_interface=MAIN_IFACE,
                          signature='sisi')
     def syncStatus(self, profileId, status, message, statusDetails):
         print("SyncStatus called", profileId, status, message, statusDetails)
 
+    # test helpers
+    @dbus.service.method(dbus_interface=MOCK_IFACE,
+                         in_signature='d', out_signature='')
+    def setTimeScale(self, scale):
+        self._timeScale = scale
+
+    @dbus.service.method(dbus_interface=MOCK_IFACE,
+                         in_signature='s', out_signature='')
+    def scheduleSync(self, profileId):
+        # sync started by msyncd itself
+        self.runSync(profileId)
+
+    @dbus.service.method(dbus_interface=MOCK_IFACE,
+                         in_signature='s', out_signature='')
+    def addProfile(self, profileId):
+        self.signalProfileChanged(profileId, 0, self.profileXml(profileId))
+
+    @dbus.service.method(dbus_interface=MOCK_IFACE,
+                         in_signature='s', out_signature='')
+    def removeProfile(self, profileId):
+        self.stopSync(profileId)
+        self.signalProfileChanged(profileId, 2, '')
+
+    @dbus.service.method(dbus_interface=MOCK_IFACE,
+                         in_signature='si', out_signature='')
+    def failSync(self, profileId, statusDetails):
+        self.stopSync(profileId)
+        #ERROR(3)
+        self.syncStatus(profileId, 3, 'failed', statusDetails)
+
+    @dbus.service.method(dbus_interface=MOCK_IFACE,
+                         in_signature='', out_signature='')
+    def restart(self):
+        # like a msyncd crash, running syncs are not reported
+        for profileId in list(self._timers.keys()):
+            self.stopSync(profileId)
+        GObject.idle_add(self.reacquireName)
+
+    @dbus.service.signal(dbus_interface=MAIN_IFACE,
+                         signature='sis')
+    def signalProfileChanged(self, profileId, changeType, profileXml):
+        print("SignalProfileChanged called", profileId, changeType)
+
+    def reacquireName(self):
+        bus = dbus.SessionBus()
+        bus.release_name(BUS_NAME)
+        bus.request_name(BUS_NAME)
+        return False
+
+    def runSync(self, profileId):
+        if profileId not in self._activeSync:
+            self._activeSync.append(profileId)
+        timers = self._timers.setdefault(profileId, [])
+        for delay, callback in ((200, self.notifySyncQueued),
+                                (400, self.notifySyncStarted),
+                                (600, self.notifySyncProgress),
+                                (800, self.notifySyncFinished)):
+            self.scheduleStep(timers, delay, callback, profileId)
+
+    def scheduleStep(self, timers, delay, callback, profileId):
+        def step():
+            timers.remove(timer)
+            return callback(profileId)
+        timer = GObject.timeout_add(max(1, int(delay * self._timeScale)), step)
+        timers.append(timer)
+
+    def stopSync(self, profileId):
+        for timer in self._timers.pop(profileId, []):
+            GObject.source_remove(timer)
+        if profileId in self._activeSync:
+            self._activeSync.remove(profileId)
+
     def notifySyncQueued(self, profileId):
         #QUEUED(0)
         self.syncStatus(profileId, 0, "", 0)
@@ -107,6 +191,7 @@ class ButeoSyncFw(dbus.service.Object):
 
     def notifySyncFinished(self, profileId):
         #DONE(4)
+        self.stopSync(profileId)
         self.syncStatus(profileId, 4, "", 100)
         return False
 
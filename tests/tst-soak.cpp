@@ -0,0 +1,267 @@
+#include "buteo-source.h"
+#include "buteo-transfer.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QDebug>
+#include <QTest>
+
+#include <gio/gio.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#define BUTEO_SERVICE_NAME  "com.meego.msyncd"
+#define BUTEO_OBJECT_PATH   "/synchronizer"
+#define BUTEO_DBUS_INTEFACE  "com.meego.msyncd"
+#define BUTEO_MOCK_INTEFACE  "com.meego.msyncd.Mock"
+
+// each cycle stands for one periodic sync interval of msyncd (in minutes),
+// played by the mock at 1% of its real time
+#define SOAK_SYNC_INTERVAL  15
+#define SOAK_TIME_SCALE     0.01
+
+#if defined(__SANITIZE_ADDRESS__)
+#define SOAK_SANITIZED
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SOAK_SANITIZED
+#endif
+#endif
+
+using namespace unity::indicator::transfer;
+
+#ifndef SOAK_SANITIZED
+// count the live C++ allocations of the whole process
+static std::atomic<long> s_liveAllocations(0);
+
+void *operator new(std::size_t size)
+{
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    s_liveAllocations++;
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr) {
+        s_liveAllocations--;
+        std::free(ptr);
+    }
+}
+#endif
+
+class TstButeoSoak : public QObject
+{
+    Q_OBJECT
+private:
+    struct Sample
+    {
+        long rss = 0;
+        long heap = 0;
+        long allocations = 0;
+    };
+
+    GDBusConnection *m_bus = nullptr;
+
+    static long envValue(const char *name, long defaultValue)
+    {
+        const char *value = getenv(name);
+        return value ? atol(value) : defaultValue;
+    }
+
+    static Sample sample()
+    {
+        Sample result;
+
+        long size = 0;
+        FILE *statm = fopen("/proc/self/statm", "r");
+        if (statm) {
+            if (fscanf(statm, "%ld %ld", &size, &result.rss) == 2) {
+                result.rss = result.rss * sysconf(_SC_PAGESIZE) / 1024;
+            } else {
+                result.rss = 0;
+            }
+            fclose(statm);
+        }
+
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 33)
+        result.heap = mallinfo2().uordblks / 1024;
+#else
+        result.heap = mallinfo().uordblks / 1024;
+#endif
+#endif
+
+#ifndef SOAK_SANITIZED
+        result.allocations = s_liveAllocations;
+#endif
+        return result;
+    }
+
+    void callMock(const char *method, GVariant *parameters)
+    {
+        GError *gError = nullptr;
+        GVariant *reply = g_dbus_connection_call_sync(m_bus,
+                                                      BUTEO_SERVICE_NAME,
+                                                      BUTEO_OBJECT_PATH,
+                                                      BUTEO_MOCK_INTEFACE,
+                                                      method,
+                                                      parameters,
+                                                      nullptr,
+                                                      G_DBUS_CALL_FLAGS_NONE,
+                                                      -1,
+                                                      nullptr,
+                                                      &gError);
+        if (gError) {
+            qWarning() << "Fail to call mock" << method << gError->message;
+            g_error_free(gError);
+        }
+        g_clear_pointer(&reply, g_variant_unref);
+    }
+
+    bool mockIdle()
+    {
+        GVariant *reply = g_dbus_connection_call_sync(m_bus,
+                                                      BUTEO_SERVICE_NAME,
+                                                      BUTEO_OBJECT_PATH,
+                                                      BUTEO_DBUS_INTEFACE,
+                                                      "runningSyncs",
+                                                      nullptr,
+                                                      G_VARIANT_TYPE("(as)"),
+                                                      G_DBUS_CALL_FLAGS_NONE,
+                                                      -1,
+                                                      nullptr,
+                                                      nullptr);
+        if (!reply) {
+            // restarting
+            return false;
+        }
+
+        GVariant *syncs = g_variant_get_child_value(reply, 0);
+        bool idle = (g_variant_n_children(syncs) == 0);
+        g_variant_unref(syncs);
+        g_variant_unref(reply);
+        return idle;
+    }
+
+    static bool pluginIdle(ButeoSource *plugin, const QStringList &profiles)
+    {
+        for (const QString &profileId : profiles) {
+            std::shared_ptr<Transfer> transfer = plugin->get_model()->get(profileId.toStdString());
+            if (transfer &&
+                ((transfer->state == Transfer::QUEUED) ||
+                 (transfer->state == Transfer::RUNNING))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        m_bus = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+        QVERIFY(m_bus);
+        callMock("setTimeScale", g_variant_new("(d)", SOAK_TIME_SCALE));
+    }
+
+    void cleanupTestCase()
+    {
+        callMock("setTimeScale", g_variant_new("(d)", 1.0));
+        g_clear_object(&m_bus);
+    }
+
+    void tst_soak()
+    {
+        const long cycles = envValue("SOAK_CYCLES", 200);
+        const long warmup = qMax(1L, cycles / 10);
+        const long rssBudget = envValue("SOAK_RSS_BUDGET_KB", 2048);
+        const long heapBudget = envValue("SOAK_HEAP_BUDGET_KB", 512);
+        const long allocationBudget = envValue("SOAK_ALLOCATION_BUDGET", 1000);
+
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        QTRY_VERIFY(plugin->connected());
+        plugin->setStartRequestWindow(0);
+
+        const QStringList profiles = QStringList() << "contacts-soak-1"
+                                                   << "contacts-soak-2"
+                                                   << "calendar-soak-1";
+        const QString scheduledProfile("calendar-soak-scheduled");
+        const QStringList allProfiles = QStringList(profiles) << scheduledProfile;
+        std::vector<Transfer::Id> ids;
+        for (const QString &profileId : profiles) {
+            ids.push_back(profileId.toStdString());
+        }
+
+        Sample baseline;
+        Sample peak;
+        for (long cycle = 0; cycle < cycles; cycle++) {
+            plugin->startAll(ids);
+            // sync started by the msyncd schedule
+            callMock("scheduleSync", g_variant_new("(s)", scheduledProfile.toUtf8().constData()));
+
+            // profile created and deleted while syncing
+            if ((cycle % 5) == 4) {
+                QByteArray temporary = QString("contacts-soak-temporary-%1").arg(cycle).toUtf8();
+                callMock("addProfile", g_variant_new("(s)", temporary.constData()));
+                plugin->start(temporary.toStdString());
+                QTRY_VERIFY(plugin->get_model()->get(temporary.toStdString()));
+                callMock("removeProfile", g_variant_new("(s)", temporary.constData()));
+                QTRY_VERIFY(!plugin->get_model()->get(temporary.toStdString()));
+            }
+
+            // msyncd restarts in the middle of the syncs
+            if ((cycle % 20) == 19) {
+                callMock("restart", nullptr);
+            }
+
+            QTRY_VERIFY_WITH_TIMEOUT(mockIdle() && pluginIdle(plugin.data(), allProfiles), 10000);
+
+            Sample current = sample();
+            if (cycle == (warmup - 1)) {
+                baseline = current;
+                peak = current;
+            }
+            peak.rss = qMax(peak.rss, current.rss);
+            peak.heap = qMax(peak.heap, current.heap);
+            peak.allocations = qMax(peak.allocations, current.allocations);
+        }
+
+        Sample last = sample();
+        qDebug() << "Simulated" << (cycles * SOAK_SYNC_INTERVAL) / 60.0 << "hours of syncs";
+        qDebug() << "RSS (kB) baseline" << baseline.rss << "peak" << peak.rss << "last" << last.rss;
+        qDebug() << "Heap (kB) baseline" << baseline.heap << "peak" << peak.heap << "last" << last.heap;
+        qDebug() << "Allocations baseline" << baseline.allocations
+                 << "peak" << peak.allocations << "last" << last.allocations;
+        qDebug() << "Suppressed start requests" << plugin->suppressedStartRequests();
+
+#ifdef SOAK_SANITIZED
+        // sanitizer shadow memory makes the numbers meaningless,
+        // leaks are reported by LeakSanitizer at exit
+        Q_UNUSED(rssBudget);
+        Q_UNUSED(heapBudget);
+        Q_UNUSED(allocationBudget);
+#else
+        QVERIFY2((last.rss - baseline.rss) <= rssBudget,
+                 qPrintable(QString("RSS grew %1 kB").arg(last.rss - baseline.rss)));
+        QVERIFY2((last.heap - baseline.heap) <= heapBudget,
+                 qPrintable(QString("Heap grew %1 kB").arg(last.heap - baseline.heap)));
+        QVERIFY2((last.allocations - baseline.allocations) <= allocationBudget,
+                 qPrintable(QString("%1 allocations leaked").arg(last.allocations - baseline.allocations)));
+#endif
+    }
+};
+
+QTEST_MAIN(TstButeoSoak)
+
+#include "tst-soak.moc"
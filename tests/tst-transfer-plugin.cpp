@@ -1,16 +1,41 @@
 #include "buteo-source.h"
 #include "buteo-transfer.h"
+#include "buteo-account-transfer.h"
+#include "buteo-profile.h"
 
 #include <QtCore/QObject>
+#include <QtCore/QMap>
 #include <QtCore/QQueue>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
 #include <QtCore/QString>
 #include <QtCore/QDebug>
-#include <QtDBus/QDBusMessage>
 #include <QTest>
 
 #define BUTEO_SERVICE_NAME  "com.meego.msyncd"
 #define BUTEO_OBJECT_PATH   "/synchronizer"
 #define BUTEO_DBUS_INTEFACE  "com.meego.msyncd"
+#define BUTEO_MOCK_INTEFACE  "com.meego.msyncd.Mock"
+
+// same profile returned by the msyncd mock
+#define MOCK_PROFILE_XML \
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+"<profile type=\"sync\" name=\"contacts-parser\">\n" \
+"    <key value=\"45\" name=\"accountid\"/>\n" \
+"    <key value=\"contacts\" name=\"category\"/>\n" \
+"    <key value=\"google-contacts-ubuntu@gmail.com\" name=\"displayname\"/>\n" \
+"    <key value=\"true\" name=\"enabled\"/>\n" \
+"    <key value=\"google-contacts\" name=\"remote_service_name\"/>\n" \
+"    <key value=\"true\" name=\"hidden\"/>\n" \
+"    <key value=\"30\" name=\"sync_since_days_past\"/>\n" \
+"    <key value=\"true\" name=\"use_accounts\"/>\n" \
+"    <profile type=\"client\" name=\"googlecontacts\">\n" \
+"        <key value=\"two-way\" name=\"Sync Direction\"/>\n" \
+"    </profile>\n" \
+"    <schedule time=\"05:00:00\" days=\"4,5,2,3,1,6,7\" syncconfiguredtime=\"\" interval=\"0\" enabled=\"true\">\n" \
+"        <rush end=\"\" externalsync=\"false\" days=\"\" interval=\"15\" begin=\"\" enabled=\"false\"/>\n" \
+"    </schedule>\n" \
+"</profile>\n"
 
 using namespace unity::indicator::transfer;
 
@@ -18,6 +43,21 @@ class TstButeoTransferPlugin : public QObject
 {
     Q_OBJECT
 private:
+    // number of main loop iterations that dispatched something
+    static int countDispatches(int msecs)
+    {
+        int dispatches = 0;
+        gint64 end = g_get_monotonic_time() + (msecs * 1000);
+        while (g_get_monotonic_time() < end) {
+            if (g_main_context_iteration(nullptr, FALSE)) {
+                dispatches++;
+            } else {
+                g_usleep(10000);
+            }
+        }
+        return dispatches;
+    }
+
     struct Event
     {
         typedef enum { ADDED, CHANGED, REMOVED } Type;
@@ -41,6 +81,48 @@ private:
         }
     };
 
+    // call one of the test helpers of the msyncd mock
+    static void callMock(const char *method, GVariant *parameters)
+    {
+        GDBusConnection *bus = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+        GVariant *reply = g_dbus_connection_call_sync(bus,
+                                                      BUTEO_SERVICE_NAME,
+                                                      BUTEO_OBJECT_PATH,
+                                                      BUTEO_MOCK_INTEFACE,
+                                                      method,
+                                                      parameters,
+                                                      nullptr,
+                                                      G_DBUS_CALL_FLAGS_NONE,
+                                                      -1,
+                                                      nullptr,
+                                                      nullptr);
+        g_clear_pointer(&reply, g_variant_unref);
+        g_object_unref(bus);
+    }
+
+    static bool serviceRunning()
+    {
+        GDBusConnection *bus = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+        GVariant *reply = g_dbus_connection_call_sync(bus,
+                                                      "org.freedesktop.DBus",
+                                                      "/org/freedesktop/DBus",
+                                                      "org.freedesktop.DBus",
+                                                      "NameHasOwner",
+                                                      g_variant_new("(s)", BUTEO_SERVICE_NAME),
+                                                      G_VARIANT_TYPE("(b)"),
+                                                      G_DBUS_CALL_FLAGS_NONE,
+                                                      -1,
+                                                      nullptr,
+                                                      nullptr);
+        gboolean running = FALSE;
+        if (reply) {
+            g_variant_get(reply, "(b)", &running);
+            g_variant_unref(reply);
+        }
+        g_object_unref(bus);
+        return running;
+    }
+
 private Q_SLOTS:
     void tst_singleSync()
     {
@@ -63,6 +145,7 @@ private Q_SLOTS:
 
         // start sync
         QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(0);
         plugin->start(QString("profile-123").toStdString());
         QTRY_COMPARE(events.size(), 5);
 
@@ -96,6 +179,420 @@ private Q_SLOTS:
         QCOMPARE(e.profileId, QStringLiteral("profile-123"));
         QCOMPARE(QString::fromStdString(e.transfer.custom_state), QStringLiteral(""));
     }
+
+    void tst_batchSync()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        QMap<QString, int> states;
+        QStringList startOrder;
+        int running = 0;
+        int maxRunning = 0;
+
+        plugin->get_model()->changed().connect([&](const Transfer::Id& id){
+            QString profileId = QString::fromStdString(id);
+            int oldState = states.value(profileId, Transfer::QUEUED);
+            int newState = plugin->get_model()->get(id)->state;
+            if ((newState == Transfer::RUNNING) && (oldState != Transfer::RUNNING)) {
+                startOrder << profileId;
+                running++;
+                maxRunning = qMax(maxRunning, running);
+            } else if ((newState != Transfer::RUNNING) && (oldState == Transfer::RUNNING)) {
+                running--;
+            }
+            states.insert(profileId, newState);
+        });
+
+        QTRY_VERIFY(plugin->connected());
+        plugin->setMaxConcurrentSyncs(1);
+        plugin->startAll({"calendar-1", "contacts-1", "contacts-2"});
+
+        // contacts go first, the others wait in the local queue once
+        // msyncd replied with their categories
+        QTRY_VERIFY(plugin->get_model()->get("contacts-2"));
+        QTRY_COMPARE(QString::fromStdString(plugin->get_model()->get("calendar-1")->custom_state),
+                     QStringLiteral("Waiting (2)"));
+        QCOMPARE(QString::fromStdString(plugin->get_model()->get("contacts-2")->custom_state),
+                 QStringLiteral("Waiting (1)"));
+
+        // an admitted sync leaves the local queue
+        QTRY_COMPARE_WITH_TIMEOUT(states.value("contacts-1"), int(Transfer::FINISHED), 10000);
+        QCOMPARE(QString::fromStdString(plugin->get_model()->get("contacts-2")->custom_state),
+                 QStringLiteral(""));
+        QCOMPARE(QString::fromStdString(plugin->get_model()->get("calendar-1")->custom_state),
+                 QStringLiteral("Waiting (1)"));
+
+        QTRY_COMPARE_WITH_TIMEOUT(states.value("calendar-1"), int(Transfer::FINISHED), 10000);
+        QCOMPARE(states.value("contacts-2"), int(Transfer::FINISHED));
+        QCOMPARE(startOrder, QStringList() << "contacts-1" << "contacts-2" << "calendar-1");
+        QCOMPARE(maxRunning, 1);
+    }
+
+    void tst_fairQueue()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        QStringList startOrder;
+
+        plugin->get_model()->changed().connect([&](const Transfer::Id& id){
+            QString profileId = QString::fromStdString(id);
+            if ((plugin->get_model()->get(id)->state == Transfer::RUNNING) &&
+                !startOrder.contains(profileId)) {
+                startOrder << profileId;
+            }
+        });
+
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(0);
+        plugin->setMaxConcurrentSyncs(1);
+        plugin->startAll({"calendar-fair", "contacts-fair-1"});
+        QTRY_COMPARE(startOrder, QStringList() << "contacts-fair-1");
+
+        // contacts requested later keep passing the calendar, but only
+        // for a limited number of admissions
+        plugin->start(QString("contacts-fair-2").toStdString());
+        QTRY_COMPARE_WITH_TIMEOUT(startOrder.size(), 2, 10000);
+        plugin->start(QString("contacts-fair-3").toStdString());
+        QTRY_COMPARE_WITH_TIMEOUT(startOrder.size(), 4, 10000);
+        QCOMPARE(startOrder, QStringList() << "contacts-fair-1"
+                                           << "contacts-fair-2"
+                                           << "calendar-fair"
+                                           << "contacts-fair-3");
+    }
+
+    void tst_scheduledWhileQueued()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        Transfer::State queuedState = Transfer::QUEUED;
+        int started = 0;
+
+        plugin->get_model()->changed().connect([&](const Transfer::Id& id){
+            if (id != "contacts-scheduled-queued") {
+                return;
+            }
+            Transfer::State state = plugin->get_model()->get(id)->state;
+            if ((state == Transfer::RUNNING) && (queuedState != Transfer::RUNNING)) {
+                started++;
+            }
+            queuedState = state;
+        });
+
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(0);
+        plugin->setMaxConcurrentSyncs(1);
+
+        // the first sync keeps the only slot for a while
+        callMock("setTimeScale", g_variant_new("(d)", 10.0));
+        plugin->startAll({"contacts-scheduled-busy", "contacts-scheduled-queued"});
+        QTRY_VERIFY(plugin->get_model()->get("contacts-scheduled-queued"));
+        QTRY_COMPARE(QString::fromStdString(plugin->get_model()->get("contacts-scheduled-queued")->custom_state),
+                     QStringLiteral("Waiting (1)"));
+        QTRY_VERIFY_WITH_TIMEOUT(plugin->get_model()->get("contacts-scheduled-busy"), 10000);
+        QTRY_COMPARE_WITH_TIMEOUT(int(plugin->get_model()->get("contacts-scheduled-busy")->state),
+                                  int(Transfer::RUNNING), 10000);
+        callMock("setTimeScale", g_variant_new("(d)", 1.0));
+
+        // msyncd syncs the queued profile on its own schedule
+        callMock("scheduleSync", g_variant_new("(s)", "contacts-scheduled-queued"));
+        QTRY_COMPARE(int(plugin->get_model()->get("contacts-scheduled-queued")->state),
+                     int(Transfer::FINISHED));
+        QCOMPARE(int(plugin->get_model()->get("contacts-scheduled-busy")->state), int(Transfer::RUNNING));
+
+        // freeing the slot does not start it again
+        QTRY_COMPARE_WITH_TIMEOUT(int(plugin->get_model()->get("contacts-scheduled-busy")->state),
+                                  int(Transfer::FINISHED), 15000);
+        QTest::qWait(1500);
+        QCOMPARE(int(plugin->get_model()->get("contacts-scheduled-queued")->state),
+                 int(Transfer::FINISHED));
+        QCOMPARE(started, 1);
+    }
+
+    void tst_repeatedStart()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        int changes = 0;
+
+        plugin->get_model()->changed().connect([&changes](const Transfer::Id& id){
+            Q_UNUSED(id);
+            changes++;
+        });
+
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(0);
+        plugin->setStartRequestWindow(60000);
+
+        // start in flight and inside the request window
+        plugin->start(QString("profile-dup").toStdString());
+        plugin->start(QString("profile-dup").toStdString());
+        plugin->start(QString("profile-dup").toStdString());
+        QCOMPARE(plugin->suppressedStartRequests(), 2);
+
+        // model shows the sync as active
+        plugin->setStartRequestWindow(0);
+        QTRY_VERIFY(plugin->get_model()->get("profile-dup"));
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-dup")->state), int(Transfer::RUNNING));
+        plugin->start(QString("profile-dup").toStdString());
+        QCOMPARE(plugin->suppressedStartRequests(), 3);
+
+        // only one sync was sent to msyncd
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-dup")->state), int(Transfer::FINISHED));
+        QTest::qWait(1000);
+        QCOMPARE(changes, 4);
+
+        // a finished sync can be started again
+        plugin->start(QString("profile-dup").toStdString());
+        QCOMPARE(plugin->suppressedStartRequests(), 3);
+        QTRY_COMPARE(changes, 8);
+    }
+
+    void tst_accountAggregation()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource(true));
+        QStringList added;
+        QStringList changed;
+
+        plugin->get_model()->added().connect([&added](const Transfer::Id& id){
+            added << QString::fromStdString(id);
+        });
+        plugin->get_model()->changed().connect([&changed](const Transfer::Id& id){
+            changed << QString::fromStdString(id);
+        });
+
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(0);
+        plugin->startAll({"contacts-45", "calendar-45"});
+
+        // both profiles belong to account 45
+        QTRY_COMPARE(added, QStringList() << "account-45");
+        std::shared_ptr<Transfer> transfer = plugin->get_model()->get("account-45");
+        QTRY_COMPARE(int(transfer->state), int(Transfer::FINISHED));
+        QCOMPARE(transfer->progress, 1.0f);
+        QVERIFY(!plugin->get_model()->get("contacts-45"));
+        QVERIFY(!plugin->get_model()->get("calendar-45"));
+
+        // each profile reports 4 status
+        QCOMPARE(changed.toSet(), QSet<QString>() << "account-45");
+        QVERIFY(changed.size() < 8);
+    }
+
+    void tst_serviceRestart()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(0);
+        plugin->setMaxConcurrentSyncs(1);
+
+        // slow down the mock so the sync is still running when it restarts
+        callMock("setTimeScale", g_variant_new("(d)", 10.0));
+        plugin->start(QString("contacts-restart").toStdString());
+        QTRY_VERIFY(plugin->get_model()->get("contacts-restart"));
+        QTRY_COMPARE_WITH_TIMEOUT(int(plugin->get_model()->get("contacts-restart")->state),
+                                  int(Transfer::RUNNING), 10000);
+
+        // msyncd will never report the end of that sync
+        callMock("restart", nullptr);
+        callMock("setTimeScale", g_variant_new("(d)", 1.0));
+        QTRY_COMPARE(int(plugin->get_model()->get("contacts-restart")->state), int(Transfer::ERROR));
+        QCOMPARE(QString::fromStdString(plugin->get_model()->get("contacts-restart")->custom_state),
+                 QStringLiteral(""));
+
+        // the only slot is free again
+        QTRY_VERIFY(serviceRunning());
+        plugin->start(QString("contacts-after-restart").toStdString());
+        QTRY_VERIFY(plugin->get_model()->get("contacts-after-restart"));
+        QTRY_COMPARE(int(plugin->get_model()->get("contacts-after-restart")->state),
+                     int(Transfer::FINISHED));
+    }
+
+    void tst_rejectedStart()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(0);
+        plugin->setMaxConcurrentSyncs(1);
+
+        // msyncd refuses to start the queued profile
+        plugin->startAll({"contacts-accepted", "rejected-1"});
+        QTRY_VERIFY(plugin->get_model()->get("rejected-1"));
+        QTRY_COMPARE_WITH_TIMEOUT(int(plugin->get_model()->get("rejected-1")->state),
+                                  int(Transfer::ERROR), 10000);
+        QCOMPARE(int(plugin->get_model()->get("contacts-accepted")->state), int(Transfer::FINISHED));
+        QVERIFY(!plugin->get_model()->get("rejected-1")->error_string.empty());
+
+        // and does not keep the only slot
+        plugin->start(QString("contacts-after-reject").toStdString());
+        QTRY_VERIFY(plugin->get_model()->get("contacts-after-reject"));
+        QTRY_COMPARE(int(plugin->get_model()->get("contacts-after-reject")->state),
+                     int(Transfer::FINISHED));
+    }
+
+    void tst_accountProgressWeights()
+    {
+        std::shared_ptr<ButeoTransfer> quick(new ButeoTransfer("contacts-weight", QVariantMap()));
+        std::shared_ptr<ButeoTransfer> slow(new ButeoTransfer("calendar-weight", QVariantMap()));
+        ButeoAccountTransfer account("account-weight", QVariantMap());
+        account.addProfile(quick);
+        account.addProfile(slow);
+
+        // a profile without history weighs as much as the known ones
+        quick->updateStatus(1, "", 0);
+        slow->updateStatus(1, "", 0);
+        QTest::qWait(10);
+        quick->updateStatus(4, "", 0);
+        account.refresh();
+        QCOMPARE(account.progress, 0.5f);
+
+        QTest::qWait(100);
+        slow->updateStatus(4, "", 0);
+        QVERIFY(slow->lastSyncDuration() > (2 * quick->lastSyncDuration()));
+
+        // the quick profile is only a small part of the account sync
+        slow->updateStatus(0, "", 0);
+        slow->updateStatus(1, "", 0);
+        account.refresh();
+        QCOMPARE(int(account.state), int(Transfer::RUNNING));
+        QVERIFY(account.progress > 0.0f);
+        QVERIFY(account.progress < 0.4f);
+    }
+
+    void tst_profileParsers()
+    {
+        QVariantMap fields = parseProfileXmlGMarkup(MOCK_PROFILE_XML);
+        QCOMPARE(fields.size(), 9);
+        QCOMPARE(fields.value("accountid").toInt(), 45);
+        QCOMPARE(fields.value("category").toString(), QStringLiteral("contacts"));
+        QCOMPARE(fields.value("Sync Direction").toString(), QStringLiteral("two-way"));
+        QVERIFY(parseProfileXmlGMarkup("<profile><key").isEmpty());
+
+#ifndef USE_GMARKUP
+        // the lean build must see the same profile as the QtXml one
+        QCOMPARE(parseProfileXmlDom(MOCK_PROFILE_XML), fields);
+        QVERIFY(parseProfileXmlDom("<profile><key").isEmpty());
+#endif
+        QCOMPARE(parseProfileXml(MOCK_PROFILE_XML), fields);
+    }
+
+    void tst_progressInterpolation()
+    {
+        ButeoTransfer transfer("profile-estimated", QVariantMap());
+
+        // nothing known about the sync rate
+        transfer.updateStatus(1, "", 10);
+        QVERIFY(!transfer.interpolateProgress(g_get_monotonic_time() + G_USEC_PER_SEC));
+        QCOMPARE(transfer.progress, 0.05f);
+
+        // 0.05 in 100ms
+        QTest::qWait(100);
+        transfer.updateStatus(2, "", 20);
+        QVERIFY(transfer.interpolateProgress(g_get_monotonic_time() + (G_USEC_PER_SEC / 5)));
+        QVERIFY(transfer.progress > 0.1f);
+        QVERIFY(transfer.progress < 0.99f);
+
+        // the estimation never reaches the end of the sync
+        QVERIFY(transfer.interpolateProgress(g_get_monotonic_time() + (100 * G_USEC_PER_SEC)));
+        QCOMPARE(transfer.progress, 0.99f);
+        float progress = transfer.progress;
+        transfer.updateStatus(2, "", 30);
+        QCOMPARE(transfer.progress, progress);
+        transfer.updateStatus(4, "", 0);
+
+        // use the last sync duration until a rate is observed
+        transfer.updateStatus(0, "", 0);
+        transfer.updateStatus(1, "", 0);
+        QCOMPARE(transfer.progress, 0.0f);
+        QVERIFY(transfer.interpolateProgress(g_get_monotonic_time() + (G_USEC_PER_SEC / 10)));
+        QVERIFY(transfer.progress > 0.0f);
+
+        // no estimation for finished syncs
+        transfer.updateStatus(4, "", 0);
+        QVERIFY(!transfer.interpolateProgress(g_get_monotonic_time() + G_USEC_PER_SEC));
+    }
+
+    void tst_initialisingProgress()
+    {
+        ButeoTransfer transfer("profile-initialising", QVariantMap());
+        transfer.updateStatus(1, "", 0);
+        QTest::qWait(10);
+        transfer.updateStatus(4, "", 0);
+
+        // nothing is estimated while the sync is initialising, even with
+        // a known sync duration
+        transfer.updateStatus(0, "", 0);
+        transfer.updateStatus(1, "", 201);
+        float progress = transfer.progress;
+        QVERIFY(!transfer.interpolateProgress(g_get_monotonic_time() + (100 * G_USEC_PER_SEC)));
+        QCOMPARE(transfer.progress, progress);
+
+        // so the receiving phase is shown from its start
+        transfer.updateStatus(2, "", 203);
+        transfer.updateStatus(2, "", 20);
+        QCOMPARE(transfer.progress, 0.1f);
+    }
+
+    void tst_deletedProfileHistory()
+    {
+        ButeoTransfer transfer("profile-deleted", QVariantMap());
+        transfer.updateStatus(1, "", 0);
+        QTest::qWait(10);
+        transfer.updateStatus(4, "", 0);
+
+        // a profile created again with the same id starts without history
+        ButeoTransfer::clearHistory("profile-deleted");
+        transfer.updateStatus(0, "", 0);
+        transfer.updateStatus(1, "", 0);
+        QVERIFY(!transfer.interpolateProgress(g_get_monotonic_time() + G_USEC_PER_SEC));
+        QCOMPARE(transfer.progress, 0.0f);
+    }
+
+    void tst_idleWakeups()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(50);
+        QVERIFY(!plugin->timersActive());
+
+        plugin->start(QString("profile-idle").toStdString());
+        QTRY_VERIFY(plugin->get_model()->get("profile-idle"));
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-idle")->state), int(Transfer::RUNNING));
+        QVERIFY(plugin->timersActive());
+
+        // the timer is gone as soon as the sync finishes
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-idle")->state), int(Transfer::FINISHED));
+        QVERIFY(!plugin->timersActive());
+
+        // nothing wakes up the main loop while idle
+        QTest::qWait(100);
+        QCOMPARE(countDispatches(1000), 0);
+    }
+
+    void tst_internalErrorStopsTimers()
+    {
+        QScopedPointer<ButeoSource> plugin(new ButeoSource);
+        QTRY_VERIFY(plugin->connected());
+        plugin->setProgressInterval(50);
+
+        plugin->start(QString("profile-internal-error").toStdString());
+        QTRY_VERIFY(plugin->get_model()->get("profile-internal-error"));
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-internal-error")->state),
+                     int(Transfer::RUNNING));
+        QVERIFY(plugin->timersActive());
+
+        // errors with the internal 401 details end the sync as well
+        callMock("failSync", g_variant_new("(si)", "profile-internal-error", 401));
+        QTRY_VERIFY(!plugin->timersActive());
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-internal-error")->state),
+                     int(Transfer::ERROR));
+        QCOMPARE(QString::fromStdString(plugin->get_model()->get("profile-internal-error")->custom_state),
+                 QStringLiteral(""));
+
+        // and the profile can be started again
+        plugin->setStartRequestWindow(0);
+        int suppressed = plugin->suppressedStartRequests();
+        plugin->start(QString("profile-internal-error").toStdString());
+        QCOMPARE(plugin->suppressedStartRequests(), suppressed);
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-internal-error")->state),
+                     int(Transfer::RUNNING));
+        QTRY_COMPARE(int(plugin->get_model()->get("profile-internal-error")->state),
+                     int(Transfer::FINISHED));
+    }
 };
 
 QTEST_MAIN(TstButeoTransferPlugin)